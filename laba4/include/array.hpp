@@ -4,11 +4,18 @@
 #include <iostream>
 #include <iomanip>
 #include <stdexcept>
+#include <unordered_map>
+#include "figure_hash.hpp"
+#include "views.hpp"
 
 template<typename E>
 class Array {
     std::vector<E> data;
 public:
+    using value_type = E;
+    using const_iterator = typename std::vector<E>::const_iterator;
+    using iterator = const_iterator;
+
     Array() = default;
     ~Array() = default;
     Array(const Array&) = delete;
@@ -19,15 +26,18 @@ public:
         data.push_back(std::move(e));
     }
 
-    E at(std::size_t idx) const {
+    const E& at(std::size_t idx) const {
         if (idx >= data.size()) throw std::out_of_range("index");
         return data[idx];
     }
 
-    E operator[](std::size_t idx) const noexcept {
+    const E& operator[](std::size_t idx) const noexcept {
         return data[idx];
     }
 
+    const_iterator begin() const noexcept { return data.begin(); }
+    const_iterator end() const noexcept { return data.end(); }
+
     std::size_t size() const noexcept {
         return data.size();
     }
@@ -53,6 +63,68 @@ public:
         return sum;
     }
 
+    auto valid() const {
+        return *this | figure_views::valid;
+    }
+
+    auto areas() const {
+        return *this | figure_views::areas;
+    }
+
+    auto centers() const {
+        return *this | figure_views::centers;
+    }
+
+    template<template<typename> class F>
+    auto ofType() const {
+        return *this | figure_views::ofType<F>;
+    }
+
+    std::vector<std::size_t> findDuplicates() const {
+        std::vector<std::size_t> dups;
+        std::unordered_map<FigureKey, std::vector<std::size_t>, FigureKeyHash> seen;
+        seen.reserve(data.size());
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            auto const& e = data[i];
+            if (!e) continue;
+            FigureKey key = figureKey(*e);
+            bool dup = false;
+            for (auto const& nk : key.neighbours()) {
+                auto it = seen.find(nk);
+                if (it == seen.end()) continue;
+                for (std::size_t j : it->second) {
+                    if (*data[j] == *e) { dup = true; break; }
+                }
+                if (dup) break;
+            }
+            if (dup) dups.push_back(i);
+            else seen[key].push_back(i);
+        }
+        return dups;
+    }
+
+    std::size_t dedupe() {
+        auto dups = findDuplicates();
+        if (dups.empty()) return 0;
+        std::size_t out = 0, next = 0;
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            if (next < dups.size() && dups[next] == i) { ++next; continue; }
+            if (out != i) data[out] = std::move(data[i]);
+            ++out;
+        }
+        data.resize(out);
+        return dups.size();
+    }
+
+    // Bytes held by the container and its figures, excluding allocator
+    // overhead and shared_ptr control blocks.
+    std::size_t memoryFootprint() const noexcept {
+        std::size_t bytes = sizeof(*this) + data.capacity() * sizeof(E);
+        for (auto const& e : data)
+            if (e) bytes += e->memoryFootprint();
+        return bytes;
+    }
+
     void printAll() const {
         std::cout << std::fixed << std::setprecision(6);
         if (data.empty()) {
@@ -77,3 +149,9 @@ public:
         }
     }
 };
+
+#ifdef FIGURES_PRECOMPILED
+extern template class Array<std::shared_ptr<Figure<float>>>;
+extern template class Array<std::shared_ptr<Figure<double>>>;
+extern template class Array<std::shared_ptr<Figure<int>>>;
+#endif
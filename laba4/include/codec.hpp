@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include "factory.hpp"
+
+// Raw binary encoding shared by the journal and the shard workers. Values
+// are copied byte for byte, so both ends must be built for the same T and
+// platform. A figure is its vertex count followed by x, y per vertex.
+namespace codec {
+    template<typename V>
+    void put(std::string& out, V v) {
+        char raw[sizeof(V)];
+        std::memcpy(raw, &v, sizeof(V));
+        out.append(raw, sizeof(V));
+    }
+
+    template<typename V>
+    bool get(const std::string& in, std::size_t& pos, std::size_t end, V& v) {
+        if (end - pos < sizeof(V)) return false;
+        std::memcpy(&v, in.data() + pos, sizeof(V));
+        pos += sizeof(V);
+        return true;
+    }
+
+    // Only the built-in shapes round-trip: decoding rebuilds a Triangle,
+    // Square or Octagon from the vertex count alone.
+    template<typename T>
+    bool canEncode(const Figure<T>& f) {
+        const std::type_info& t = typeid(f);
+        return t == typeid(Triangle<T>) || t == typeid(Square<T>) || t == typeid(Octagon<T>);
+    }
+
+    template<typename T>
+    void putFigure(std::string& out, const Figure<T>& f) {
+        put(out, static_cast<std::uint8_t>(f.size()));
+        for (std::size_t i = 0; i < f.size(); ++i) {
+            put(out, f.getPoint(i).getX());
+            put(out, f.getPoint(i).getY());
+        }
+    }
+
+    template<typename T>
+    std::shared_ptr<Figure<T>> getFigure(const std::string& in, std::size_t& pos, std::size_t end) {
+        std::uint8_t n = 0;
+        if (!get(in, pos, end, n)) return nullptr;
+        if (n != 3 && n != 4 && n != 8) return nullptr;
+        std::shared_ptr<Figure<T>> f = makeFigure<T>(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            T x, y;
+            if (!get(in, pos, end, x) || !get(in, pos, end, y)) return nullptr;
+            f->setPoint(i, Point<T>(x, y));
+        }
+        return f;
+    }
+}
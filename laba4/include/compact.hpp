@@ -0,0 +1,186 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "kernels.hpp"
+#include "factory.hpp"
+#include "array.hpp"
+
+enum class Encoding {
+    Float32,
+    Int32,
+    Int16
+};
+
+// Figures packed as offsets from their first vertex. Float32 keeps the
+// offsets as floats; Int32 and Int16 store round(offset / quantum).
+// Kernels decode vertices on the fly, nothing is materialized per figure.
+// Validity checks use an absolute 1e-6 tolerance on squared sides, so any
+// error in the stored offsets can turn a correct figure into an incorrect
+// one. Float32 offsets carry about 1e-7 relative error, which already breaks
+// validity (and with it totalArea) for figures a few units across; use it
+// only for footprint-critical data where validity is not checked. The
+// default Int32 with quantum 1e-7 keeps validity for offsets up to ~214.
+// A quantum much coarser than 1e-7 has the same problem as Float32.
+template<typename T>
+requires std::is_arithmetic_v<T>
+class CompactArray {
+    struct Record {
+        double ox;
+        double oy;
+        std::uint64_t offset : 56;
+        std::uint64_t length : 8;
+    };
+
+    std::vector<Record> records;
+    std::vector<float> f32;
+    std::vector<std::int32_t> i32;
+    std::vector<std::int16_t> i16;
+    Encoding enc;
+    double quantum;
+
+    template<typename I>
+    static I quantize(long double v, double q) {
+        long double r = std::round(v / static_cast<long double>(q));
+        if (!(r >= std::numeric_limits<I>::min() && r <= std::numeric_limits<I>::max()))
+            throw std::out_of_range("quantum");
+        return static_cast<I>(r);
+    }
+
+    template<typename I>
+    static void encode(const Figure<T>& f, const Record& r, double q, std::vector<I>& out) {
+        std::vector<I> tmp;
+        tmp.reserve(2 * r.length);
+        for (std::size_t i = 0; i < r.length; ++i) {
+            tmp.push_back(quantize<I>(static_cast<long double>(f.pointAt(i).getX()) - r.ox, q));
+            tmp.push_back(quantize<I>(static_cast<long double>(f.pointAt(i).getY()) - r.oy, q));
+        }
+        out.insert(out.end(), tmp.begin(), tmp.end());
+    }
+
+    auto reader(std::size_t idx) const {
+        const Record& r = records[idx];
+        return [this, &r](std::size_t i) {
+            std::size_t k = r.offset + 2 * i;
+            long double dx = 0.0L, dy = 0.0L;
+            switch (enc) {
+                case Encoding::Float32:
+                    dx = f32[k];
+                    dy = f32[k + 1];
+                    break;
+                case Encoding::Int32:
+                    dx = static_cast<long double>(i32[k]) * quantum;
+                    dy = static_cast<long double>(i32[k + 1]) * quantum;
+                    break;
+                case Encoding::Int16:
+                    dx = static_cast<long double>(i16[k]) * quantum;
+                    dy = static_cast<long double>(i16[k + 1]) * quantum;
+                    break;
+            }
+            return kernels::Vec2{r.ox + dx, r.oy + dy};
+        };
+    }
+
+public:
+    explicit CompactArray(Encoding e = Encoding::Int32, double q = 1e-7) : enc(e), quantum(q) {
+        if (!(q > 0.0)) throw std::invalid_argument("quantum");
+    }
+
+    template<typename E>
+    static CompactArray from(const Array<E>& arr, Encoding e = Encoding::Int32, double q = 1e-7) {
+        CompactArray res(e, q);
+        res.reserve(arr.size());
+        for (std::size_t i = 0; i < arr.size(); ++i)
+            if (arr[i]) res.push_back(*arr[i]);
+        return res;
+    }
+
+    void reserve(std::size_t n) {
+        records.reserve(n);
+    }
+
+    void push_back(const Figure<T>& f) {
+        std::size_t n = f.size();
+        if (n != 3 && n != 4 && n != 8) throw std::invalid_argument("figure");
+        Record r{static_cast<double>(f.pointAt(0).getX()), static_cast<double>(f.pointAt(0).getY()), 0, n};
+        switch (enc) {
+            case Encoding::Float32:
+                r.offset = f32.size();
+                for (std::size_t i = 0; i < n; ++i) {
+                    f32.push_back(static_cast<float>(static_cast<double>(f.pointAt(i).getX()) - r.ox));
+                    f32.push_back(static_cast<float>(static_cast<double>(f.pointAt(i).getY()) - r.oy));
+                }
+                break;
+            case Encoding::Int32:
+                r.offset = i32.size();
+                encode(f, r, quantum, i32);
+                break;
+            case Encoding::Int16:
+                r.offset = i16.size();
+                encode(f, r, quantum, i16);
+                break;
+        }
+        records.push_back(r);
+    }
+
+    std::size_t size() const noexcept {
+        return records.size();
+    }
+
+    Encoding encoding() const noexcept { return enc; }
+    double getQuantum() const noexcept { return quantum; }
+
+    double area(std::size_t idx) const {
+        if (idx >= records.size()) throw std::out_of_range("index");
+        return static_cast<double>(kernels::area(reader(idx), records[idx].length));
+    }
+
+    Point<T> center(std::size_t idx) const {
+        if (idx >= records.size()) throw std::out_of_range("index");
+        std::size_t n = records[idx].length;
+        kernels::Vec2 c = n == 8 ? kernels::polygonCentroid(reader(idx), n) : kernels::vertexMean(reader(idx), n);
+        return Point<T>(static_cast<T>(c.x), static_cast<T>(c.y));
+    }
+
+    bool isCorrect(std::size_t idx) const {
+        if (idx >= records.size()) throw std::out_of_range("index");
+        switch (records[idx].length) {
+            case 3: return kernels::triangleCorrect(reader(idx));
+            case 4: return kernels::squareCorrect(reader(idx));
+            default: return kernels::octagonCorrect(reader(idx));
+        }
+    }
+
+    double totalArea() const noexcept {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < records.size(); ++i)
+            if (isCorrect(i)) sum += area(i);
+        return sum;
+    }
+
+    std::shared_ptr<Figure<T>> decode(std::size_t idx) const {
+        if (idx >= records.size()) throw std::out_of_range("index");
+        std::shared_ptr<Figure<T>> f = makeFigure<T>(records[idx].length);
+        auto at = reader(idx);
+        for (std::size_t i = 0; i < f->size(); ++i) {
+            kernels::Vec2 p = at(i);
+            if constexpr (std::is_integral_v<T>)
+                f->setPoint(i, Point<T>(static_cast<T>(std::llround(p.x)), static_cast<T>(std::llround(p.y))));
+            else
+                f->setPoint(i, Point<T>(static_cast<T>(p.x), static_cast<T>(p.y)));
+        }
+        return f;
+    }
+
+    // Bytes held by the container, excluding allocator overhead.
+    std::size_t memoryFootprint() const noexcept {
+        return sizeof(*this)
+            + records.capacity() * sizeof(Record)
+            + f32.capacity() * sizeof(float)
+            + i32.capacity() * sizeof(std::int32_t)
+            + i16.capacity() * sizeof(std::int16_t);
+    }
+};
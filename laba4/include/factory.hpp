@@ -0,0 +1,17 @@
+#pragma once
+#include <memory>
+#include <stdexcept>
+#include "triangle.hpp"
+#include "square.hpp"
+#include "octagon.hpp"
+
+template<typename T>
+requires std::is_arithmetic_v<T>
+std::shared_ptr<Figure<T>> makeFigure(std::size_t length) {
+    switch (length) {
+        case 3: return std::make_shared<Triangle<T>>();
+        case 4: return std::make_shared<Square<T>>();
+        case 8: return std::make_shared<Octagon<T>>();
+        default: throw std::invalid_argument("figure");
+    }
+}
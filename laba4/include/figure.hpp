@@ -4,21 +4,41 @@
 #include <memory>
 #include <type_traits>
 #include "point.hpp"
+#include "kernels.hpp"
 
 template <typename T>
 requires std::is_arithmetic_v<T>
 class Figure {
 protected:
-    std::vector<std::unique_ptr<Point<T>>> points;
+    // Vertices are shared between copies and duplicated on first mutation.
+    // Once a mutable reference has been handed out by pointAt() the buffer
+    // stops being shared, so copies taken later cannot observe writes made
+    // through that reference. Read through getPoint() to keep sharing.
+    std::shared_ptr<std::vector<Point<T>>> points;
     std::size_t length;
+    bool shareable = true;
 
     void rebuild_points_if_needed() {
-        if (points.size() != length) {
-            points.clear();
-            points.reserve(length);
-            for (std::size_t i = 0; i < length; ++i)
-                points.push_back(std::make_unique<Point<T>>(Point<T>()));
-        }
+        if (!points || points->size() != length)
+            points = std::make_shared<std::vector<Point<T>>>(length);
+    }
+
+    void detach() {
+        rebuild_points_if_needed();
+        if (points.use_count() > 1)
+            points = std::make_shared<std::vector<Point<T>>>(*points);
+    }
+
+    std::shared_ptr<std::vector<Point<T>>> share() const {
+        if (shareable || !points) return points;
+        return std::make_shared<std::vector<Point<T>>>(*points);
+    }
+
+    auto reader() const {
+        return [this](std::size_t i) {
+            const Point<T>& p = (*points)[i];
+            return kernels::Vec2{static_cast<long double>(p.getX()), static_cast<long double>(p.getY())};
+        };
     }
 
 public:
@@ -34,41 +54,37 @@ public:
     virtual std::unique_ptr<Figure<T>> clone() const = 0;
 
     virtual void input(std::istream& is) {
-        rebuild_points_if_needed();
+        detach();
         for (std::size_t i = 0; i < length; ++i) {
             T x, y;
             is >> x >> y;
-            points[i]->setX(x);
-            points[i]->setY(y);
+            (*points)[i].setX(x);
+            (*points)[i].setY(y);
         }
     }
 
     virtual void output(std::ostream& os) const {
-        for (std::size_t i = 0; i < length; ++i) os << *points[i] << " ";
+        for (std::size_t i = 0; i < length; ++i) os << (*points)[i] << " ";
     }
 
     bool operator==(const Figure& other) const {
         if (length != other.length) return false;
+        if (points == other.points) return true;
         for (std::size_t i = 0; i < length; ++i)
-            if (!(*points[i] == *other.points[i])) return false;
+            if (!((*points)[i] == (*other.points)[i])) return false;
         return true;
     }
 
-    Figure(const Figure& other) : points(), length(other.length) {
-        points.reserve(length);
-        for (std::size_t i = 0; i < other.length; ++i)
-            points.push_back(std::make_unique<Point<T>>(*other.points[i]));
-    }
+    Figure(const Figure& other) : points(other.share()), length(other.length) {}
 
-    Figure(Figure&& other) noexcept : points(std::move(other.points)), length(other.length) {}
+    Figure(Figure&& other) noexcept
+        : points(std::move(other.points)), length(other.length), shareable(other.shareable) {}
 
     Figure& operator=(const Figure& other) {
         if (this != &other) {
             length = other.length;
-            points.clear();
-            points.reserve(length);
-            for (std::size_t i = 0; i < other.length; ++i)
-                points.push_back(std::make_unique<Point<T>>(*other.points[i]));
+            points = other.share();
+            shareable = true;
         }
         return *this;
     }
@@ -77,20 +93,43 @@ public:
         if (this != &other) {
             length = other.length;
             points = std::move(other.points);
+            shareable = other.shareable;
         }
         return *this;
     }
 
     Point<T>& pointAt(std::size_t idx) {
-        return *points[idx];
+        detach();
+        shareable = false;
+        return (*points)[idx];
     }
 
     const Point<T>& pointAt(std::size_t idx) const {
-        return *points[idx];
+        return (*points)[idx];
+    }
+
+    const Point<T>& getPoint(std::size_t idx) const {
+        return (*points)[idx];
+    }
+
+    void setPoint(std::size_t idx, const Point<T>& p) {
+        detach();
+        (*points)[idx] = p;
     }
 
     std::size_t size() const noexcept { return length; }
 
+    // Bytes owned by this figure, excluding allocator overhead. A vertex
+    // buffer shared by several copies is split evenly between them.
+    std::size_t memoryFootprint() const noexcept {
+        std::size_t bytes = sizeof(Figure);
+        if (points) {
+            std::size_t buffer = sizeof(*points) + points->capacity() * sizeof(Point<T>);
+            bytes += buffer / static_cast<std::size_t>(points.use_count());
+        }
+        return bytes;
+    }
+
     friend std::istream& operator>>(std::istream& is, Figure<T>& f) {
         f.input(is);
         return is;
@@ -101,3 +140,9 @@ public:
         return os;
     }
 };
+
+#ifdef FIGURES_PRECOMPILED
+extern template class Figure<float>;
+extern template class Figure<double>;
+extern template class Figure<int>;
+#endif
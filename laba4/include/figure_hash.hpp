@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include "figure.hpp"
+
+// Grid cell of a figure built from quantities that do not depend on which
+// vertex comes first: vertex sum and spread around the mean. Figures equal
+// under operator== (|dx|, |dy| < 1e-6 per vertex) land in the same or an
+// adjacent cell on every axis, so a lookup has to probe the 3x3x3 neighbours.
+// Cell indices are whole numbers kept as long double, so they never clamp or
+// overflow; past 2^64 a +-1 shift is absorbed, but there the coordinates are
+// already far coarser than EPS.
+struct FigureKey {
+    std::size_t length;
+    long double sx;
+    long double sy;
+    long double spread;
+
+    bool operator==(const FigureKey& other) const = default;
+
+    FigureKey shifted(int dx, int dy, int ds) const {
+        return FigureKey{length, sx + dx, sy + dy, spread + ds};
+    }
+
+    std::array<FigureKey, 27> neighbours() const {
+        std::array<FigureKey, 27> res{};
+        std::size_t k = 0;
+        for (int dx = -1; dx <= 1; ++dx)
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int ds = -1; ds <= 1; ++ds)
+                    res[k++] = shifted(dx, dy, ds);
+        return res;
+    }
+};
+
+struct FigureKeyHash {
+    std::size_t operator()(const FigureKey& k) const noexcept {
+        std::size_t h = std::hash<std::size_t>{}(k.length);
+        auto mix = [&h](long double v) {
+            h ^= std::hash<long double>{}(v) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        };
+        mix(k.sx);
+        mix(k.sy);
+        mix(k.spread);
+        return h;
+    }
+};
+
+namespace detail {
+    inline long double quantize(long double v, long double cell) {
+        long double q = std::floor(v / cell);
+        if (!std::isfinite(q)) return 0.0L;
+        return q + 0.0L;
+    }
+}
+
+template<typename T>
+requires std::is_arithmetic_v<T>
+FigureKey figureKey(const Figure<T>& f) {
+    constexpr long double EPS = 1e-6L;
+    const std::size_t n = f.size();
+    if (n == 0) return FigureKey{0, 0, 0, 0};
+
+    long double sx = 0.0L, sy = 0.0L;
+    for (std::size_t i = 0; i < n; ++i) {
+        sx += static_cast<long double>(f.pointAt(i).getX());
+        sy += static_cast<long double>(f.pointAt(i).getY());
+    }
+    long double mx = sx / static_cast<long double>(n);
+    long double my = sy / static_cast<long double>(n);
+    long double spread = 0.0L;
+    for (std::size_t i = 0; i < n; ++i) {
+        spread += std::fabs(static_cast<long double>(f.pointAt(i).getX()) - mx);
+        spread += std::fabs(static_cast<long double>(f.pointAt(i).getY()) - my);
+    }
+
+    // Each vertex moves by less than EPS per axis, so the sums move by less
+    // than n*EPS and the spread by less than 4*n*EPS.
+    const long double cell = 4.0L * static_cast<long double>(n) * EPS;
+    return FigureKey{n, detail::quantize(sx, cell), detail::quantize(sy, cell), detail::quantize(spread, cell)};
+}
+
+// Hash of a figure's own cell, not a hash consistent with operator==: two
+// figures within EPS can sit in adjacent cells and hash differently. Do not
+// use it as the hasher of an unordered container keyed by figure equality;
+// look figures up by probing figureKey(f).neighbours() as
+// Array::findDuplicates does. It is fine wherever any stable bucket will
+// do, e.g. picking a shard.
+struct FigureBucketHash {
+    template<typename T>
+    std::size_t operator()(const Figure<T>& f) const noexcept {
+        return FigureKeyHash{}(figureKey(f));
+    }
+};
@@ -0,0 +1,301 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include "array.hpp"
+#include "codec.hpp"
+
+// Array backed by a directory with two files:
+//   journal     - append-only log of push_back/removeAt/clear records
+//   checkpoint  - full snapshot, replaced atomically by checkpoint()
+// Every record carries a sequence number and the checkpoint remembers the
+// last one it contains, so a crash between writing the checkpoint and
+// truncating the journal never applies a record twice. Records are
+// buffered and written with one write+fsync per batch (group commit); a
+// torn or corrupt tail left by a crash is cut off on recovery. Once
+// checkpointEvery records have been committed since the last checkpoint,
+// commit() writes a new one, which bounds both the journal and recovery.
+template<typename T>
+requires std::is_arithmetic_v<T>
+class JournaledArray {
+public:
+    using FigurePtr = std::shared_ptr<Figure<T>>;
+
+private:
+    enum class Op : std::uint8_t {
+        Push = 1,
+        Remove = 2,
+        Clear = 3
+    };
+
+    static constexpr std::uint32_t JOURNAL_MAGIC = 0x4c4e4a46;    // "FJNL"
+    static constexpr std::uint32_t CHECKPOINT_MAGIC = 0x504b4346; // "FCKP"
+    static constexpr std::size_t HEADER_SIZE = 8;
+
+    Array<FigurePtr> arr;
+    std::filesystem::path dir;
+    std::size_t batch;
+    std::size_t pending = 0;
+    std::size_t checkpointEvery;
+    std::size_t sinceCheckpoint = 0;
+    std::string buffer;
+    std::uint64_t seq = 0;
+    int fd = -1;
+
+    static std::uint32_t checksum(const char* p, std::size_t n) {
+        std::uint32_t h = 2166136261u;
+        for (std::size_t i = 0; i < n; ++i) {
+            h ^= static_cast<unsigned char>(p[i]);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    static std::string header(std::uint32_t magic) {
+        std::string h;
+        codec::put(h, magic);
+        codec::put(h, static_cast<std::uint32_t>(sizeof(T)));
+        return h;
+    }
+
+    static void writeAll(int out, const char* p, std::size_t n) {
+        while (n > 0) {
+            ssize_t w = ::write(out, p, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("journal write");
+            }
+            p += w;
+            n -= static_cast<std::size_t>(w);
+        }
+    }
+
+    static std::string readFile(const std::filesystem::path& p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void record(Op op, const std::string& payload) {
+        std::string body;
+        codec::put(body, ++seq);
+        codec::put(body, static_cast<std::uint8_t>(op));
+        body += payload;
+        codec::put(buffer, static_cast<std::uint32_t>(body.size()));
+        codec::put(buffer, checksum(body.data(), body.size()));
+        buffer += body;
+        if (++pending >= batch) commit();
+    }
+
+    std::uint64_t loadCheckpoint() {
+        auto path = dir / "checkpoint";
+        if (!std::filesystem::exists(path)) return 0;
+        std::string data = readFile(path);
+        std::size_t pos = 0;
+        std::uint32_t magic = 0, width = 0, sum = 0;
+        std::uint64_t last = 0, count = 0;
+        if (!codec::get(data, pos, data.size(), magic) || !codec::get(data, pos, data.size(), width)
+            || magic != CHECKPOINT_MAGIC || width != sizeof(T) || data.size() < HEADER_SIZE + 4)
+            throw std::runtime_error("checkpoint");
+        std::size_t end = data.size() - 4;
+        std::size_t tail = end;
+        codec::get(data, tail, data.size(), sum);
+        if (sum != checksum(data.data() + HEADER_SIZE, end - HEADER_SIZE))
+            throw std::runtime_error("checkpoint");
+        if (!codec::get(data, pos, end, last) || !codec::get(data, pos, end, count))
+            throw std::runtime_error("checkpoint");
+        for (std::uint64_t i = 0; i < count; ++i) {
+            FigurePtr f = codec::getFigure<T>(data, pos, end);
+            if (!f) throw std::runtime_error("checkpoint");
+            arr.push_back(std::move(f));
+        }
+        return last;
+    }
+
+    // Replays records newer than the checkpoint and returns the length of
+    // the valid prefix of the journal. Only a short or checksum-failing
+    // record is a torn tail; a record that checks out but cannot be applied
+    // means the journal is corrupt, and cutting it off would drop later
+    // committed records.
+    std::size_t replay(const std::string& data, std::uint64_t last) {
+        std::size_t pos = HEADER_SIZE;
+        while (pos < data.size()) {
+            std::size_t start = pos;
+            std::uint32_t size = 0, sum = 0;
+            if (!codec::get(data, pos, data.size(), size) || !codec::get(data, pos, data.size(), sum)) return start;
+            if (data.size() - pos < size || checksum(data.data() + pos, size) != sum) return start;
+            std::size_t end = pos + size;
+            std::uint64_t s = 0;
+            std::uint8_t op = 0;
+            if (!codec::get(data, pos, end, s) || !codec::get(data, pos, end, op))
+                throw std::runtime_error("journal record");
+            if (s > last) {
+                ++sinceCheckpoint;
+                switch (static_cast<Op>(op)) {
+                    case Op::Push: {
+                        FigurePtr f = codec::getFigure<T>(data, pos, end);
+                        if (!f) throw std::runtime_error("journal record");
+                        arr.push_back(std::move(f));
+                        break;
+                    }
+                    case Op::Remove: {
+                        std::uint64_t idx = 0;
+                        if (!codec::get(data, pos, end, idx)) throw std::runtime_error("journal record");
+                        arr.removeAt(static_cast<std::size_t>(idx));
+                        break;
+                    }
+                    case Op::Clear:
+                        arr.clear();
+                        break;
+                    default:
+                        throw std::runtime_error("journal record");
+                }
+            }
+            seq = std::max(seq, s);
+            pos = end;
+        }
+        return pos;
+    }
+
+    void recover() {
+        std::filesystem::create_directories(dir);
+        seq = loadCheckpoint();
+        std::uint64_t last = seq;
+
+        auto path = dir / "journal";
+        std::string data = readFile(path);
+        std::size_t good = HEADER_SIZE;
+        if (data.size() >= HEADER_SIZE) {
+            if (data.compare(0, HEADER_SIZE, header(JOURNAL_MAGIC)) != 0)
+                throw std::runtime_error("journal");
+            good = replay(data, last);
+        }
+
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) throw std::runtime_error("journal open");
+        if (data.size() < HEADER_SIZE) {
+            if (::ftruncate(fd, 0) != 0) throw std::runtime_error("journal truncate");
+            std::string h = header(JOURNAL_MAGIC);
+            writeAll(fd, h.data(), h.size());
+            ::fsync(fd);
+        } else if (good < data.size()) {
+            if (::ftruncate(fd, static_cast<off_t>(good)) != 0) throw std::runtime_error("journal truncate");
+            ::fsync(fd);
+        }
+    }
+
+public:
+    // checkpointEvery == 0 leaves checkpoints to explicit checkpoint() calls.
+    explicit JournaledArray(std::filesystem::path d, std::size_t batchSize = 64, std::size_t checkpointEvery = 4096)
+        : dir(std::move(d)), batch(batchSize == 0 ? 1 : batchSize), checkpointEvery(checkpointEvery) {
+        recover();
+    }
+
+    ~JournaledArray() {
+        try { commit(); } catch (...) {}
+        if (fd >= 0) ::close(fd);
+    }
+
+    JournaledArray(const JournaledArray&) = delete;
+    JournaledArray& operator=(const JournaledArray&) = delete;
+
+    // Stores a copy, so the caller's figure can change without bypassing
+    // the journal; the copy shares its vertex buffer until then. Only
+    // Triangle, Square and Octagon can be journaled.
+    void push_back(const FigurePtr& f) {
+        if (f == nullptr) return;
+        if (!codec::canEncode(*f)) throw std::invalid_argument("figure");
+        std::string payload;
+        codec::putFigure(payload, *f);
+        arr.push_back(FigurePtr(f->clone()));
+        record(Op::Push, payload);
+    }
+
+    bool removeAt(std::size_t idx) {
+        if (!arr.removeAt(idx)) return false;
+        std::string payload;
+        codec::put(payload, static_cast<std::uint64_t>(idx));
+        record(Op::Remove, payload);
+        return true;
+    }
+
+    void clear() {
+        arr.clear();
+        record(Op::Clear, std::string());
+    }
+
+    // On failure the journal is cut back to where the batch started, so a
+    // retry never leaves a torn record in front of later batches.
+    void commit() {
+        if (buffer.empty()) return;
+        off_t start = ::lseek(fd, 0, SEEK_END);
+        if (start < 0) throw std::runtime_error("journal seek");
+        try {
+            writeAll(fd, buffer.data(), buffer.size());
+            if (::fsync(fd) != 0) throw std::runtime_error("journal fsync");
+        } catch (...) {
+            if (::ftruncate(fd, start) == 0) ::fsync(fd);
+            throw;
+        }
+        buffer.clear();
+        sinceCheckpoint += pending;
+        pending = 0;
+        if (checkpointEvery != 0 && sinceCheckpoint >= checkpointEvery) checkpoint();
+    }
+
+    void checkpoint() {
+        commit();
+        std::string data = header(CHECKPOINT_MAGIC);
+        codec::put(data, seq);
+        codec::put(data, static_cast<std::uint64_t>(arr.size()));
+        for (auto const& f : arr) codec::putFigure(data, *f);
+        codec::put(data, checksum(data.data() + HEADER_SIZE, data.size() - HEADER_SIZE));
+
+        auto tmp = dir / "checkpoint.tmp";
+        int out = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out < 0) throw std::runtime_error("checkpoint open");
+        try {
+            writeAll(out, data.data(), data.size());
+            if (::fsync(out) != 0) throw std::runtime_error("checkpoint fsync");
+        } catch (...) {
+            ::close(out);
+            throw;
+        }
+        ::close(out);
+        std::filesystem::rename(tmp, dir / "checkpoint");
+        int d = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (d >= 0) {
+            ::fsync(d);
+            ::close(d);
+        }
+
+        if (::ftruncate(fd, static_cast<off_t>(HEADER_SIZE)) != 0) throw std::runtime_error("journal truncate");
+        ::fsync(fd);
+        sinceCheckpoint = 0;
+    }
+
+    // Figures are read-only here; every change has to be journaled.
+    const Figure<T>& at(std::size_t idx) const {
+        return *arr.at(idx);
+    }
+
+    const Figure<T>& operator[](std::size_t idx) const noexcept {
+        return *arr[idx];
+    }
+
+    auto figures() const {
+        return arr | std::views::transform([](const FigurePtr& f) -> const Figure<T>& { return *f; });
+    }
+
+    double totalArea() const noexcept { return arr.totalArea(); }
+    std::size_t size() const noexcept { return arr.size(); }
+    std::size_t uncommitted() const noexcept { return pending; }
+};
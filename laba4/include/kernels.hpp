@@ -0,0 +1,105 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+// Geometry shared by the figure classes and the compact storage. Every
+// kernel reads vertices through an accessor `at(i)` returning Vec2, so the
+// same code runs over Point<T> buffers and over encoded offsets.
+namespace kernels {
+    struct Vec2 {
+        long double x;
+        long double y;
+    };
+
+    template<typename At>
+    long double shoelace(const At& at, std::size_t n) {
+        long double acc = 0.0L;
+        for (std::size_t i = 0; i < n; ++i) {
+            Vec2 a = at(i);
+            Vec2 b = at((i + 1) % n);
+            acc += a.x * b.y - b.x * a.y;
+        }
+        return acc;
+    }
+
+    template<typename At>
+    long double area(const At& at, std::size_t n) {
+        return 0.5L * std::fabs(shoelace(at, n));
+    }
+
+    template<typename At>
+    Vec2 vertexMean(const At& at, std::size_t n) {
+        long double sx = 0.0L, sy = 0.0L;
+        for (std::size_t i = 0; i < n; ++i) {
+            Vec2 p = at(i);
+            sx += p.x;
+            sy += p.y;
+        }
+        return Vec2{sx / static_cast<long double>(n), sy / static_cast<long double>(n)};
+    }
+
+    template<typename At>
+    Vec2 polygonCentroid(const At& at, std::size_t n) {
+        constexpr long double EPS = 1e-9L;
+        long double area2 = 0.5L * shoelace(at, n);
+        if (std::fabs(area2) < EPS) return Vec2{0.0L, 0.0L};
+        long double cx = 0.0L, cy = 0.0L;
+        for (std::size_t i = 0; i < n; ++i) {
+            Vec2 a = at(i);
+            Vec2 b = at((i + 1) % n);
+            long double cross = a.x * b.y - b.x * a.y;
+            cx += (a.x + b.x) * cross;
+            cy += (a.y + b.y) * cross;
+        }
+        return Vec2{cx / (6.0L * area2), cy / (6.0L * area2)};
+    }
+
+    template<typename At>
+    bool equalSides(const At& at, std::size_t n) {
+        constexpr long double EPS = 1e-6L;
+        long double first = 0.0L;
+        for (std::size_t i = 0; i < n; ++i) {
+            Vec2 a = at(i);
+            Vec2 b = at((i + 1) % n);
+            long double dx = b.x - a.x;
+            long double dy = b.y - a.y;
+            long double len = dx*dx + dy*dy;
+            if (len < EPS) return false;
+            if (i == 0) first = len;
+            else if (std::fabs(len - first) > EPS) return false;
+        }
+        return true;
+    }
+
+    // Unlike equalSides, compares consecutive sides with a strict bound, as
+    // Triangle always has.
+    template<typename At>
+    bool triangleCorrect(const At& at) {
+        constexpr long double EPS = 1e-6L;
+        long double ds[3];
+        for (std::size_t i = 0; i < 3; ++i) {
+            Vec2 a = at(i);
+            Vec2 b = at((i + 1) % 3);
+            long double dx = b.x - a.x;
+            long double dy = b.y - a.y;
+            ds[i] = dx*dx + dy*dy;
+            if (ds[i] < EPS) return false;
+        }
+        return (std::fabs(ds[0] - ds[1]) < EPS) && (std::fabs(ds[1] - ds[2]) < EPS);
+    }
+
+    template<typename At>
+    bool squareCorrect(const At& at) {
+        constexpr long double EPS = 1e-6L;
+        if (!equalSides(at, 4)) return false;
+        Vec2 p0 = at(0), p1 = at(1), p2 = at(2);
+        long double dot = (p1.x - p0.x) * (p2.x - p1.x) + (p1.y - p0.y) * (p2.y - p1.y);
+        return std::fabs(dot) < EPS;
+    }
+
+    template<typename At>
+    bool octagonCorrect(const At& at) {
+        if (!equalSides(at, 8)) return false;
+        return area(at, 8) >= 1e-9L;
+    }
+}
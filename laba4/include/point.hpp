@@ -57,3 +57,9 @@ bool operator==(const Point<T>& a, const Point<T>& b) {
         return a.getX() == b.getX() && a.getY() == b.getY();
     }
 }
+
+#ifdef FIGURES_PRECOMPILED
+extern template class Point<float>;
+extern template class Point<double>;
+extern template class Point<int>;
+#endif
@@ -0,0 +1,267 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "array.hpp"
+#include "codec.hpp"
+#include "figure_hash.hpp"
+#include "triangle.hpp"
+#include "square.hpp"
+#include "octagon.hpp"
+
+struct TypeStats {
+    std::size_t count = 0;
+    std::size_t valid = 0;
+    double area = 0.0;
+};
+
+// Partial result of a pass over figures. Partials computed on disjoint
+// subsets merge into the same result as a single pass; the area sum is
+// compensated (Neumaier) so the merge order barely affects rounding.
+struct Aggregate {
+    enum Type { TriangleType, SquareType, OctagonType, TypeCount };
+
+    std::size_t count = 0;
+    std::size_t valid = 0;
+    double areaSum = 0.0;
+    double areaComp = 0.0;
+    double minX = std::numeric_limits<double>::infinity();
+    double minY = std::numeric_limits<double>::infinity();
+    double maxX = -std::numeric_limits<double>::infinity();
+    double maxY = -std::numeric_limits<double>::infinity();
+    std::array<TypeStats, TypeCount> types{};
+
+    double totalArea() const noexcept { return areaSum + areaComp; }
+
+    void addArea(double x) noexcept {
+        double t = areaSum + x;
+        if (std::fabs(areaSum) >= std::fabs(x)) areaComp += (areaSum - t) + x;
+        else areaComp += (x - t) + areaSum;
+        areaSum = t;
+    }
+
+    template<typename T>
+    void add(const Figure<T>& f) {
+        ++count;
+        for (std::size_t i = 0; i < f.size(); ++i) {
+            double x = static_cast<double>(f.pointAt(i).getX());
+            double y = static_cast<double>(f.pointAt(i).getY());
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+        }
+        int type = -1;
+        if (dynamic_cast<const Triangle<T>*>(&f)) type = TriangleType;
+        else if (dynamic_cast<const Square<T>*>(&f)) type = SquareType;
+        else if (dynamic_cast<const Octagon<T>*>(&f)) type = OctagonType;
+        if (type >= 0) ++types[type].count;
+
+        bool ok = false;
+        double area = 0.0;
+        try {
+            ok = f.isCorrect();
+            if (ok) area = static_cast<double>(f);
+        } catch (...) { ok = false; }
+        if (!ok) return;
+        ++valid;
+        addArea(area);
+        if (type >= 0) {
+            ++types[type].valid;
+            types[type].area += area;
+        }
+    }
+
+    void merge(const Aggregate& o) noexcept {
+        count += o.count;
+        valid += o.valid;
+        addArea(o.areaSum);
+        areaComp += o.areaComp;
+        minX = std::min(minX, o.minX);
+        minY = std::min(minY, o.minY);
+        maxX = std::max(maxX, o.maxX);
+        maxY = std::max(maxY, o.maxY);
+        for (std::size_t i = 0; i < types.size(); ++i) {
+            types[i].count += o.types[i].count;
+            types[i].valid += o.types[i].valid;
+            types[i].area += o.types[i].area;
+        }
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<Aggregate>);
+
+enum class Partition {
+    Hash,
+    Cell
+};
+
+template<typename T>
+requires std::is_arithmetic_v<T>
+std::size_t shardOf(const Figure<T>& f, std::size_t shards, Partition p, double cell = 1.0) {
+    if (p == Partition::Hash) return FigureBucketHash{}(f) % shards;
+    long double sx = 0.0L, sy = 0.0L;
+    for (std::size_t i = 0; i < f.size(); ++i) {
+        sx += static_cast<long double>(f.pointAt(i).getX());
+        sy += static_cast<long double>(f.pointAt(i).getY());
+    }
+    long double n = static_cast<long double>(f.size() == 0 ? 1 : f.size());
+    long double cx = detail::quantize(sx / n, cell);
+    long double cy = detail::quantize(sy / n, cell);
+    return FigureKeyHash{}(FigureKey{0, cx, cy, 0}) % shards;
+}
+
+template<typename E>
+Aggregate aggregate(const Array<E>& arr) {
+    Aggregate res;
+    for (auto const& e : arr)
+        if (e) res.add(*e);
+    return res;
+}
+
+namespace detail {
+    inline void closeAll(const std::vector<int>& fds) {
+        for (int fd : fds) ::close(fd);
+    }
+
+    inline bool readAll(int fd, char* p, std::size_t n) {
+        while (n > 0) {
+            ssize_t r = ::read(fd, p, n);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            p += r;
+            n -= static_cast<std::size_t>(r);
+        }
+        return true;
+    }
+
+    inline bool writeAll(int fd, const char* p, std::size_t n) {
+        while (n > 0) {
+            ssize_t w = ::send(fd, p, n, MSG_NOSIGNAL);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) return false;
+            p += w;
+            n -= static_cast<std::size_t>(w);
+        }
+        return true;
+    }
+
+    // Worker side: decodes figures from fd until the coordinator shuts down
+    // its end, aggregating them as they arrive.
+    template<typename T>
+    bool runShardWorker(int fd, Aggregate& part) {
+        std::string buf;
+        char chunk[1 << 16];
+        for (;;) {
+            ssize_t r = ::read(fd, chunk, sizeof(chunk));
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) return false;
+            if (r == 0) break;
+            buf.append(chunk, static_cast<std::size_t>(r));
+            std::size_t pos = 0;
+            for (;;) {
+                std::size_t start = pos;
+                auto f = codec::getFigure<T>(buf, pos, buf.size());
+                if (!f) {
+                    pos = start;
+                    break;
+                }
+                part.add(*f);
+            }
+            buf.erase(0, pos);
+        }
+        return buf.empty();
+    }
+}
+
+// Splits arr into shards and streams each shard's figures to its own
+// forked worker over a local socket. Workers rebuild and aggregate only
+// what they receive, never the coordinator's memory, and send back a
+// partial Aggregate that is merged in shard order. Figures travel through
+// codec, so only Triangle, Square and Octagon are accepted; anything else
+// throws invalid_argument before any worker starts, since it would be
+// rebuilt as a different shape or not at all.
+template<typename E>
+Aggregate shardedAggregate(const Array<E>& arr, std::size_t shards, Partition p = Partition::Hash, double cell = 1.0) {
+    using T = typename figure_views::scalar_of<std::remove_cvref_t<decltype(*std::declval<const E&>())>>::type;
+    if (shards == 0) throw std::invalid_argument("shards");
+    if (!(cell > 0.0)) throw std::invalid_argument("cell");
+    for (auto const& e : arr)
+        if (e && !codec::canEncode(*e)) throw std::invalid_argument("figure");
+
+    std::vector<int> fds;
+    std::vector<pid_t> pids;
+    for (std::size_t s = 0; s < shards; ++s) {
+        int sv[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+            detail::closeAll(fds);
+            for (pid_t pid : pids) ::waitpid(pid, nullptr, 0);
+            throw std::runtime_error("socketpair");
+        }
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            ::close(sv[0]);
+            ::close(sv[1]);
+            detail::closeAll(fds);
+            for (pid_t q : pids) ::waitpid(q, nullptr, 0);
+            throw std::runtime_error("fork");
+        }
+        if (pid == 0) {
+            ::close(sv[0]);
+            detail::closeAll(fds);
+            bool ok = false;
+            try {
+                Aggregate part;
+                ok = detail::runShardWorker<T>(sv[1], part)
+                    && detail::writeAll(sv[1], reinterpret_cast<const char*>(&part), sizeof(part));
+            } catch (...) { ok = false; }
+            ::close(sv[1]);
+            ::_exit(ok ? 0 : 1);
+        }
+        ::close(sv[1]);
+        fds.push_back(sv[0]);
+        pids.push_back(pid);
+    }
+
+    bool ok = true;
+    std::vector<std::string> out(shards);
+    for (auto const& e : arr) {
+        if (!ok) break;
+        if (!e) continue;
+        std::size_t s = shardOf(*e, shards, p, cell);
+        codec::putFigure(out[s], *e);
+        if (out[s].size() >= (1 << 16)) {
+            ok = detail::writeAll(fds[s], out[s].data(), out[s].size());
+            out[s].clear();
+        }
+    }
+    for (std::size_t s = 0; s < shards; ++s) {
+        if (ok && !out[s].empty()) ok = detail::writeAll(fds[s], out[s].data(), out[s].size());
+        ::shutdown(fds[s], SHUT_WR);
+    }
+
+    Aggregate res;
+    for (std::size_t s = 0; s < shards; ++s) {
+        Aggregate part;
+        if (ok && detail::readAll(fds[s], reinterpret_cast<char*>(&part), sizeof(part))) res.merge(part);
+        else ok = false;
+    }
+    detail::closeAll(fds);
+    for (pid_t pid : pids) {
+        int status = 0;
+        if (::waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+    }
+    if (!ok) throw std::runtime_error("shard worker");
+    return res;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include "figure.hpp"
+
+// Lazy adaptors over ranges of figure pointers. They compose with each
+// other and with std::views, e.g. arr | figure_views::valid | figure_views::areas.
+namespace figure_views {
+    template<typename F>
+    struct scalar_of;
+
+    template<typename T>
+    struct scalar_of<Figure<T>> {
+        using type = T;
+    };
+
+    inline constexpr auto valid = std::views::filter([](auto const& e) {
+        return e != nullptr && e->isCorrect();
+    });
+
+    inline constexpr auto areas = std::views::transform([](auto const& e) {
+        return static_cast<double>(*e);
+    });
+
+    inline constexpr auto centers = std::views::transform([](auto const& e) {
+        return e->getCenter();
+    });
+
+    template<template<typename> class F>
+    inline constexpr auto ofType =
+        std::views::filter([](auto const& e) {
+            using T = typename scalar_of<std::remove_cvref_t<decltype(*e)>>::type;
+            return dynamic_cast<const F<T>*>(std::to_address(e)) != nullptr;
+        })
+        | std::views::transform([](auto const& e) -> decltype(auto) {
+            using T = typename scalar_of<std::remove_cvref_t<decltype(*e)>>::type;
+            return static_cast<const F<T>&>(*e);
+        });
+}
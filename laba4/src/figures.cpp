@@ -0,0 +1,30 @@
+#include "point.hpp"
+#include "figure.hpp"
+#include "triangle.hpp"
+#include "square.hpp"
+#include "octagon.hpp"
+#include "array.hpp"
+
+template class Point<float>;
+template class Point<double>;
+template class Point<int>;
+
+template class Figure<float>;
+template class Figure<double>;
+template class Figure<int>;
+
+template class Triangle<float>;
+template class Triangle<double>;
+template class Triangle<int>;
+
+template class Square<float>;
+template class Square<double>;
+template class Square<int>;
+
+template class Octagon<float>;
+template class Octagon<double>;
+template class Octagon<int>;
+
+template class Array<std::shared_ptr<Figure<float>>>;
+template class Array<std::shared_ptr<Figure<double>>>;
+template class Array<std::shared_ptr<Figure<int>>>;
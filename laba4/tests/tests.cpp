@@ -5,10 +5,25 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <utility>
+#include <unordered_map>
+#include <iomanip>
+#include <numeric>
+#include <ranges>
+#include <filesystem>
+#include <fstream>
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "../include/triangle.hpp"
 #include "../include/square.hpp"
 #include "../include/octagon.hpp"
 #include "../include/array.hpp"
+#include "../include/compact.hpp"
+#include "../include/journal.hpp"
+#include "../include/shard.hpp"
 
 using T = double;
 using FigurePtr = std::shared_ptr<Figure<T>>;
@@ -69,6 +84,16 @@ TEST(TriangleInvalid, CollinearPointsInvalid) {
     EXPECT_NEAR(area, 0.0, EPS);
 }
 
+TEST(TriangleBasic, ConsecutiveSidesWithinEps) {
+    Triangle<T> tri;
+    double x = 0.5 + 0.4e-6;
+    double y = std::sqrt(1.0 + 1.6e-6 - x * x);
+    tri.setPoint(0, Point<T>(0, 0));
+    tri.setPoint(1, Point<T>(1, 0));
+    tri.setPoint(2, Point<T>(x, y));
+    EXPECT_TRUE(tri.isCorrect());
+}
+
 TEST(SquareBasic, UnitSquareCorrect) {
     auto sq = create_square("0 0 1 0 1 1 0 1");
     EXPECT_TRUE(sq->isCorrect());
@@ -306,3 +331,610 @@ TEST(Additional, PrintAllOutputContainsPoints) {
     EXPECT_NE(out.find("(0"), std::string::npos);
     EXPECT_NE(out.find("(1"), std::string::npos);
 }
+
+TEST(FigureBucketHash, CyclicVertexOrderSameKey) {
+    auto a = create_square("0 0 1 0 1 1 0 1");
+    auto b = create_square("1 1 0 1 0 0 1 0");
+    EXPECT_EQ(figureKey(*a), figureKey(*b));
+    EXPECT_EQ(FigureBucketHash{}(*a), FigureBucketHash{}(*b));
+}
+
+TEST(FigureBucketHash, NearEqualFiguresInNeighbourCells) {
+    for (int k = 0; k < 50; ++k) {
+        double base = 0.1 + k * 3.7e-6;
+        Triangle<T> a, b;
+        std::istringstream ia(std::to_string(base) + " 0 1 0 0.5 0.866025");
+        ia >> a;
+        b = a;
+        b.setPoint(0, Point<T>(a.getPoint(0).getX() + 9e-7, a.getPoint(0).getY()));
+        ASSERT_TRUE(a == b);
+        auto ka = figureKey(a);
+        auto kb = figureKey(b);
+        EXPECT_LE(std::fabs(ka.sx - kb.sx), 1.0L);
+        EXPECT_LE(std::fabs(ka.sy - kb.sy), 1.0L);
+        EXPECT_LE(std::fabs(ka.spread - kb.spread), 1.0L);
+    }
+}
+
+TEST(ArrayDedupe, FindDuplicatesWithinEps) {
+    Array<FigurePtr> container;
+    container.push_back(create_triangle("0 0 1 0 0.5 0.866025"));
+    container.push_back(create_square("0 0 1 0 1 1 0 1"));
+    container.push_back(create_triangle("0.0000004 0 1 0 0.5 0.866025"));
+    container.push_back(create_square("0 0 1 0 1 1 0 1.00001"));
+    container.push_back(create_square("0 0 1 0 1 1 0 1"));
+    auto dups = container.findDuplicates();
+    ASSERT_EQ(dups.size(), 2u);
+    EXPECT_EQ(dups[0], 2u);
+    EXPECT_EQ(dups[1], 4u);
+}
+
+TEST(FigureBucketHash, LargeCoordinatesKeepDistinctCells) {
+    Array<FigurePtr> container;
+    std::unordered_map<FigureKey, int, FigureKeyHash> keys;
+    for (int i = 0; i < 300; ++i) {
+        double x = 1e15 + (i % 100);
+        std::ostringstream coords;
+        coords << std::setprecision(17) << x << " 0 " << x + 1 << " 0 " << x + 1 << " 1 " << x << " 1";
+        auto sq = create_square(coords.str());
+        ++keys[figureKey(*sq)];
+        for (auto const& nk : figureKey(*sq).neighbours()) EXPECT_TRUE(std::isfinite(nk.sx));
+        container.push_back(sq);
+    }
+    EXPECT_EQ(keys.size(), 100u);
+    EXPECT_EQ(container.dedupe(), 200u);
+    EXPECT_EQ(container.size(), 100u);
+}
+
+TEST(ArrayDedupe, KeepsFirstOccurrenceInOrder) {
+    Array<FigurePtr> container;
+    for (int i = 0; i < 200; ++i) {
+        double off = static_cast<double>(i % 10);
+        std::ostringstream coords;
+        coords << off << " 0 " << off + 1 << " 0 " << off + 1 << " 1 " << off << " 1";
+        container.push_back(create_square(coords.str()));
+    }
+    EXPECT_EQ(container.dedupe(), 190u);
+    ASSERT_EQ(container.size(), 10u);
+    for (std::size_t i = 0; i < container.size(); ++i)
+        EXPECT_NEAR(container[i]->getPoint(0).getX(), static_cast<double>(i), 1e-9);
+    EXPECT_EQ(container.dedupe(), 0u);
+}
+
+TEST(CopyOnWrite, CloneSharesUntilMutation) {
+    auto sq = create_square("0 0 1 0 1 1 0 1");
+    auto copy = sq->clone();
+    EXPECT_EQ(&sq->getPoint(0), &copy->getPoint(0));
+    copy->pointAt(0).setX(-1);
+    EXPECT_NE(&sq->getPoint(0), &copy->getPoint(0));
+    EXPECT_NEAR(sq->getPoint(0).getX(), 0.0, 1e-9);
+    EXPECT_NEAR(copy->getPoint(0).getX(), -1.0, 1e-9);
+    EXPECT_TRUE(sq->isCorrect());
+}
+
+TEST(CopyOnWrite, ReadThroughArrayKeepsSharing) {
+    Array<FigurePtr> container;
+    container.push_back(create_square("0 0 1 0 1 1 0 1"));
+    double sum = 0.0;
+    for (std::size_t k = 0; k < container[0]->size(); ++k) sum += container[0]->getPoint(k).getX();
+    EXPECT_NEAR(sum, 2.0, 1e-9);
+    auto copy = container[0]->clone();
+    EXPECT_EQ(&container[0]->getPoint(0), &copy->getPoint(0));
+}
+
+TEST(CopyOnWrite, InputOnCopyLeavesOriginal) {
+    Triangle<T> a;
+    std::istringstream ia("0 0 1 0 0.5 0.866025");
+    ia >> a;
+    Triangle<T> b(a);
+    std::istringstream ib("0 0 2 0 1 1.73205");
+    ib >> b;
+    EXPECT_NEAR(static_cast<double>(a), expected_equilateral_area(), EPS);
+    EXPECT_NEAR(static_cast<double>(b), 4 * expected_equilateral_area(), EPS);
+}
+
+TEST(CopyOnWrite, HeldReferenceNotVisibleInLaterCopy) {
+    Triangle<T> a;
+    std::istringstream ia("0 0 1 0 0.5 0.866025");
+    ia >> a;
+    Point<T>& p = a.pointAt(0);
+    Triangle<T> b(a);
+    p.setX(5);
+    EXPECT_NEAR(a.getPoint(0).getX(), 5.0, 1e-9);
+    EXPECT_NEAR(b.getPoint(0).getX(), 0.0, 1e-9);
+}
+
+static const char* OCTAGON_SHIFTED =
+    "3.000000 1.000000 2.414214 2.414214 1.000000 3.000000 -0.414214 2.414214 "
+    "-1.000000 1.000000 -0.414214 -0.414214 1.000000 -1.000000 2.414214 -0.414214";
+
+TEST(CompactArray, KernelsMatchFigures) {
+    Array<FigurePtr> container;
+    container.push_back(create_triangle("0 0 1 0 0.5 0.866025"));
+    container.push_back(create_square("0 0 1 0 1 1 0 1"));
+    container.push_back(create_octagon(OCTAGON_SHIFTED));
+    container.push_back(create_square("0 0 2 0 2 1 0 1"));
+    for (Encoding e : {Encoding::Float32, Encoding::Int32}) {
+        auto compact = CompactArray<T>::from(container, e, 1e-7);
+        ASSERT_EQ(compact.size(), container.size());
+        for (std::size_t i = 0; i < container.size(); ++i) {
+            EXPECT_EQ(compact.isCorrect(i), container[i]->isCorrect());
+            EXPECT_NEAR(compact.area(i), static_cast<double>(*container[i]), 1e-3);
+            auto c = compact.center(i);
+            EXPECT_NEAR(c.getX(), container[i]->getCenter().getX(), 1e-3);
+            EXPECT_NEAR(c.getY(), container[i]->getCenter().getY(), 1e-3);
+        }
+        EXPECT_NEAR(compact.totalArea(), container.totalArea(), 1e-3);
+    }
+}
+
+TEST(CompactArray, DecodeRoundTripWithinQuantum) {
+    CompactArray<T> compact(Encoding::Int32, 1e-6);
+    auto oc = create_octagon(OCTAGON_SHIFTED);
+    compact.push_back(*oc);
+    auto back = compact.decode(0);
+    EXPECT_TRUE(*back == *oc);
+    EXPECT_TRUE(back->isCorrect());
+}
+
+TEST(CompactArray, Int16OverflowThrows) {
+    CompactArray<T> compact(Encoding::Int16, 1e-6);
+    auto sq = create_square("0 0 1 0 1 1 0 1");
+    EXPECT_THROW(compact.push_back(*sq), std::out_of_range);
+    EXPECT_EQ(compact.size(), 0u);
+    EXPECT_THROW(CompactArray<T>(Encoding::Int16, 0.0), std::invalid_argument);
+}
+
+TEST(CompactArray, SmallerFootprint) {
+    Array<FigurePtr> container;
+    for (int i = 0; i < 100; ++i) container.push_back(create_octagon(OCTAGON_SHIFTED));
+    auto compact = CompactArray<T>::from(container, Encoding::Int16, 1e-3);
+    EXPECT_LT(compact.memoryFootprint() * 3, container.memoryFootprint());
+    EXPECT_NEAR(compact.totalArea(), container.totalArea(), 0.5);
+}
+
+TEST(ArrayIteration, RangeForYieldsReferences) {
+    Array<FigurePtr> container;
+    container.push_back(create_triangle("0 0 1 0 0.5 0.866025"));
+    container.push_back(create_square("0 0 1 0 1 1 0 1"));
+    static_assert(std::ranges::random_access_range<const Array<FigurePtr>>);
+    std::size_t n = 0;
+    for (auto const& f : container) {
+        EXPECT_EQ(&f, &container[n]);
+        ++n;
+    }
+    EXPECT_EQ(n, container.size());
+    EXPECT_EQ(std::ranges::distance(container), 2);
+    EXPECT_EQ(container[0].use_count(), 1);
+}
+
+TEST(ArrayViews, ValidAreasMatchTotalArea) {
+    Array<FigurePtr> container;
+    container.push_back(create_triangle("0 0 1 1 2 2"));
+    container.push_back(create_square("0 0 1 0 1 1 0 1"));
+    container.push_back(create_triangle("0 0 1 0 0.5 0.866025"));
+    auto areas = container.valid() | figure_views::areas;
+    double sum = std::accumulate(areas.begin(), areas.end(), 0.0);
+    EXPECT_NEAR(sum, container.totalArea(), 1e-9);
+    EXPECT_EQ(std::ranges::distance(container.valid()), 2);
+    EXPECT_EQ(std::ranges::distance(container.areas()), 3);
+    auto centers = container.centers();
+    EXPECT_NEAR((*std::ranges::next(centers.begin())).getX(), 0.5, 1e-9);
+}
+
+TEST(ArrayViews, OfTypeFiltersAndComposes) {
+    Array<FigurePtr> container;
+    container.push_back(create_square("0 0 1 0 1 1 0 1"));
+    container.push_back(create_octagon(OCTAGON_SHIFTED));
+    container.push_back(create_square("0 0 2 0 2 1 0 1"));
+    container.push_back(create_square("0 0 2 0 2 2 0 2"));
+    std::size_t n = 0;
+    for (const Square<T>& sq : container.ofType<Square>()) {
+        EXPECT_EQ(sq.size(), 4u);
+        ++n;
+    }
+    EXPECT_EQ(n, 3u);
+    auto big = container | figure_views::valid | figure_views::ofType<Square>
+        | std::views::transform([](const Square<T>& sq) { return static_cast<double>(sq); })
+        | std::views::filter([](double a) { return a > 2.0; });
+    EXPECT_EQ(std::ranges::distance(big), 1);
+    EXPECT_EQ(std::ranges::distance(container.ofType<Octagon>()), 1);
+}
+
+static std::filesystem::path fresh_dir(const std::string& name) {
+    auto dir = std::filesystem::temp_directory_path() / ("laba4_" + name + "_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(dir);
+    return dir;
+}
+
+static FigurePtr unit_square_at(int off) {
+    std::ostringstream coords;
+    coords << off << " 0 " << off + 1 << " 0 " << off + 1 << " 1 " << off << " 1";
+    return create_square(coords.str());
+}
+
+class Pentagon : public Figure<T> {
+public:
+    Pentagon(): Figure<T>(5) {}
+    bool isCorrect() const override { return true; }
+    Point<T> getCenter() const override { return Point<T>(); }
+    operator double() const override { return 1.0; }
+    std::unique_ptr<Figure<T>> clone() const override { return std::make_unique<Pentagon>(*this); }
+};
+
+class Quad : public Figure<T> {
+public:
+    Quad(): Figure<T>(4) {}
+    bool isCorrect() const override { return true; }
+    Point<T> getCenter() const override { return Point<T>(); }
+    operator double() const override { return 2.0; }
+    std::unique_ptr<Figure<T>> clone() const override { return std::make_unique<Quad>(*this); }
+};
+
+static std::uint32_t fnv1a(const std::string& s) {
+    std::uint32_t h = 2166136261u;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+TEST(Journal, ReplaysOperationsAfterReopen) {
+    auto dir = fresh_dir("replay");
+    {
+        JournaledArray<T> j(dir, 4);
+        for (int i = 0; i < 10; ++i) j.push_back(unit_square_at(i));
+        EXPECT_TRUE(j.removeAt(0));
+        EXPECT_FALSE(j.removeAt(100));
+        j.push_back(create_triangle("0 0 1 0 0.5 0.866025"));
+    }
+    JournaledArray<T> j(dir);
+    ASSERT_EQ(j.size(), 10u);
+    EXPECT_NEAR(j[0].getPoint(0).getX(), 1.0, 1e-12);
+    EXPECT_EQ(j[9].size(), 3u);
+    EXPECT_NEAR(j.totalArea(), 9.0 + expected_equilateral_area(), EPS);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(Journal, StoresCopyOfPushedFigure) {
+    auto dir = fresh_dir("copy");
+    auto sq = unit_square_at(0);
+    {
+        JournaledArray<T> j(dir);
+        j.push_back(sq);
+        sq->pointAt(0).setX(42);
+        EXPECT_NEAR(j[0].getPoint(0).getX(), 0.0, 1e-12);
+        j.checkpoint();
+    }
+    JournaledArray<T> j(dir);
+    EXPECT_NEAR(j[0].getPoint(0).getX(), 0.0, 1e-12);
+    std::size_t n = 0;
+    for (const Figure<T>& f : j.figures()) n += f.size();
+    EXPECT_EQ(n, 4u);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(Journal, FailedCommitLeavesNoTornRecord) {
+    auto dir = fresh_dir("failed_commit");
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        try {
+            ::signal(SIGXFSZ, SIG_IGN);
+            JournaledArray<T> j(dir, 100);
+            for (int i = 0; i < 5; ++i) j.push_back(unit_square_at(i));
+            j.commit();
+            struct rlimit lim;
+            ::getrlimit(RLIMIT_FSIZE, &lim);
+            struct rlimit small = lim;
+            small.rlim_cur = std::filesystem::file_size(dir / "journal") + 100;
+            ::setrlimit(RLIMIT_FSIZE, &small);
+            for (int i = 5; i < 10; ++i) j.push_back(unit_square_at(i));
+            bool threw = false;
+            try { j.commit(); } catch (const std::runtime_error&) { threw = true; }
+            ::setrlimit(RLIMIT_FSIZE, &lim);
+            if (!threw) ::_exit(3);
+            j.commit();
+            for (int i = 10; i < 12; ++i) j.push_back(unit_square_at(i));
+            j.commit();
+        } catch (...) {
+            ::_exit(2);
+        }
+        ::_exit(0);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    JournaledArray<T> j(dir);
+    ASSERT_EQ(j.size(), 12u);
+    for (std::size_t i = 0; i < j.size(); ++i)
+        EXPECT_NEAR(j[i].getPoint(0).getX(), static_cast<double>(i), 1e-12);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(Journal, RejectsFiguresCodecCannotRoundTrip) {
+    auto dir = fresh_dir("reject");
+    {
+        JournaledArray<T> j(dir, 1);
+        j.push_back(unit_square_at(0));
+        EXPECT_THROW(j.push_back(std::make_shared<Pentagon>()), std::invalid_argument);
+        EXPECT_THROW(j.push_back(std::make_shared<Quad>()), std::invalid_argument);
+        EXPECT_EQ(j.size(), 1u);
+        for (int i = 0; i < 5; ++i) j.push_back(create_triangle("0 0 1 0 0.5 0.866025"));
+        j.checkpoint();
+        j.push_back(unit_square_at(1));
+    }
+    JournaledArray<T> j(dir);
+    EXPECT_EQ(j.size(), 7u);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(Journal, UndecodableCommittedRecordIsNotTreatedAsTornTail) {
+    auto dir = fresh_dir("undecodable");
+    {
+        JournaledArray<T> j(dir, 1);
+        j.push_back(unit_square_at(0));
+    }
+    std::string body;
+    std::uint64_t seq = 2;
+    std::uint8_t op = 1, n = 5;
+    body.append(reinterpret_cast<const char*>(&seq), sizeof(seq));
+    body.append(reinterpret_cast<const char*>(&op), 1);
+    body.append(reinterpret_cast<const char*>(&n), 1);
+    body.append(10 * sizeof(T), '\0');
+    std::uint32_t size = static_cast<std::uint32_t>(body.size()), sum = fnv1a(body);
+    auto before = std::filesystem::file_size(dir / "journal");
+    {
+        std::ofstream out(dir / "journal", std::ios::binary | std::ios::app);
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.write(reinterpret_cast<const char*>(&sum), sizeof(sum));
+        out << body;
+    }
+    EXPECT_THROW(JournaledArray<T> j(dir), std::runtime_error);
+    EXPECT_EQ(std::filesystem::file_size(dir / "journal"), before + 8 + body.size());
+    std::filesystem::remove_all(dir);
+}
+
+TEST(Journal, CheckpointTruncatesJournal) {
+    auto dir = fresh_dir("checkpoint");
+    {
+        JournaledArray<T> j(dir);
+        for (int i = 0; i < 50; ++i) j.push_back(unit_square_at(i));
+        j.checkpoint();
+        EXPECT_EQ(std::filesystem::file_size(dir / "journal"), 8u);
+        j.removeAt(49);
+        j.clear();
+        j.push_back(unit_square_at(7));
+    }
+    JournaledArray<T> j(dir);
+    ASSERT_EQ(j.size(), 1u);
+    EXPECT_NEAR(j[0].getPoint(0).getX(), 7.0, 1e-12);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(Journal, AutomaticCheckpointsBoundJournal) {
+    auto dir = fresh_dir("auto_checkpoint");
+    std::uintmax_t largest = 0;
+    {
+        JournaledArray<T> j(dir, 10, 100);
+        for (int i = 0; i < 1000; ++i) {
+            j.push_back(unit_square_at(i));
+            largest = std::max(largest, std::filesystem::file_size(dir / "journal"));
+        }
+        j.removeAt(0);
+    }
+    std::string one;
+    codec::putFigure(one, *unit_square_at(0));
+    EXPECT_LE(largest, 8 + 100 * (8 + 9 + one.size()));
+    EXPECT_TRUE(std::filesystem::exists(dir / "checkpoint"));
+    JournaledArray<T> j(dir);
+    ASSERT_EQ(j.size(), 999u);
+    EXPECT_NEAR(j[0].getPoint(0).getX(), 1.0, 1e-12);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(Journal, TornTailIsDiscarded) {
+    auto dir = fresh_dir("torn");
+    {
+        JournaledArray<T> j(dir, 1);
+        for (int i = 0; i < 3; ++i) j.push_back(unit_square_at(i));
+    }
+    auto good = std::filesystem::file_size(dir / "journal");
+    {
+        std::ofstream out(dir / "journal", std::ios::binary | std::ios::app);
+        out.write("\x40\x00\x00\x00\x12\x34", 6);
+    }
+    {
+        JournaledArray<T> j(dir);
+        EXPECT_EQ(j.size(), 3u);
+        EXPECT_EQ(std::filesystem::file_size(dir / "journal"), good);
+        j.push_back(unit_square_at(3));
+    }
+    JournaledArray<T> j(dir);
+    EXPECT_EQ(j.size(), 4u);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(Journal, UncommittedBatchLostOnKill) {
+    auto dir = fresh_dir("uncommitted");
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        try {
+            JournaledArray<T> j(dir, 100);
+            for (int i = 0; i < 10; ++i) j.push_back(unit_square_at(i));
+            j.commit();
+            for (int i = 10; i < 15; ++i) j.push_back(unit_square_at(i));
+            ::raise(SIGKILL);
+        } catch (...) {
+            ::_exit(2);
+        }
+        ::_exit(1);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFSIGNALED(status));
+    JournaledArray<T> j(dir);
+    EXPECT_EQ(j.size(), 10u);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(Journal, RecoversAfterKillMidWrite) {
+    auto dir = fresh_dir("kill");
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        try {
+            JournaledArray<T> j(dir, 1, 40);
+            for (int i = 0; i < 100000; ++i) j.push_back(unit_square_at(i));
+        } catch (...) {
+            ::_exit(2);
+        }
+        ::_exit(0);
+    }
+    auto journal = dir / "journal";
+    for (int spin = 0; spin < 20000; ++spin) {
+        std::error_code ec;
+        if (std::filesystem::exists(dir / "checkpoint", ec) && std::filesystem::file_size(journal, ec) > 1000) break;
+        ::usleep(100);
+    }
+    ::kill(pid, SIGKILL);
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+
+    JournaledArray<T> j(dir);
+    ASSERT_GE(j.size(), 40u);
+    for (std::size_t i = 0; i < j.size(); ++i) {
+        ASSERT_NEAR(j[i].getPoint(0).getX(), static_cast<double>(i), 1e-12);
+        ASSERT_TRUE(j[i].isCorrect());
+    }
+    std::filesystem::remove_all(dir);
+}
+
+static void fill_mixed(Array<FigurePtr>& container, int n) {
+    for (int i = 0; i < n; ++i) {
+        double s = 1.0 + (i % 17) * 0.37;
+        double ox = (i % 23) * 3.1 - 30.0;
+        double oy = (i % 19) * 2.7 - 20.0;
+        std::ostringstream coords;
+        coords << std::setprecision(17);
+        switch (i % 4) {
+            case 0:
+                coords << ox << " " << oy << " " << ox + s << " " << oy << " " << ox + s << " " << oy + s << " " << ox << " " << oy + s;
+                container.push_back(create_square(coords.str()));
+                break;
+            case 1:
+                coords << ox << " " << oy << " " << ox + s << " " << oy << " " << ox + s / 2 << " " << oy + s * std::sqrt(3.0) / 2;
+                container.push_back(create_triangle(coords.str()));
+                break;
+            case 2:
+                for (int k = 0; k < 8; ++k)
+                    coords << ox + s * std::cos(k * M_PI / 4) << " " << oy + s * std::sin(k * M_PI / 4) << " ";
+                container.push_back(create_octagon(coords.str()));
+                break;
+            default:
+                coords << ox << " " << oy << " " << ox + 2 * s << " " << oy << " " << ox + 2 * s << " " << oy + s << " " << ox << " " << oy + s;
+                container.push_back(create_square(coords.str()));
+                break;
+        }
+    }
+}
+
+static void expect_same_aggregate(const Aggregate& a, const Aggregate& b) {
+    EXPECT_EQ(a.count, b.count);
+    EXPECT_EQ(a.valid, b.valid);
+    EXPECT_DOUBLE_EQ(a.totalArea(), b.totalArea());
+    EXPECT_EQ(a.minX, b.minX);
+    EXPECT_EQ(a.minY, b.minY);
+    EXPECT_EQ(a.maxX, b.maxX);
+    EXPECT_EQ(a.maxY, b.maxY);
+    for (std::size_t i = 0; i < a.types.size(); ++i) {
+        EXPECT_EQ(a.types[i].count, b.types[i].count);
+        EXPECT_EQ(a.types[i].valid, b.types[i].valid);
+        EXPECT_NEAR(a.types[i].area, b.types[i].area, 1e-9 * (1.0 + a.types[i].area));
+    }
+}
+
+TEST(Sharding, SingleProcessAggregateMatchesArray) {
+    Array<FigurePtr> container;
+    fill_mixed(container, 400);
+    Aggregate a = aggregate(container);
+    EXPECT_EQ(a.count, 400u);
+    EXPECT_EQ(a.valid, 300u);
+    EXPECT_EQ(a.types[Aggregate::SquareType].count, 200u);
+    EXPECT_EQ(a.types[Aggregate::SquareType].valid, 100u);
+    EXPECT_NEAR(a.totalArea(), container.totalArea(), 1e-9 * container.totalArea());
+}
+
+TEST(Sharding, HashAndCellShardsMatchSingleProcess) {
+    Array<FigurePtr> container;
+    fill_mixed(container, 2000);
+    Aggregate single = aggregate(container);
+    for (std::size_t shards : {1u, 3u, 8u}) {
+        expect_same_aggregate(shardedAggregate(container, shards, Partition::Hash), single);
+        expect_same_aggregate(shardedAggregate(container, shards, Partition::Cell, 5.0), single);
+    }
+}
+
+TEST(Sharding, EmptyArrayAndBadArguments) {
+    Array<FigurePtr> container;
+    Aggregate a = shardedAggregate(container, 4);
+    EXPECT_EQ(a.count, 0u);
+    EXPECT_EQ(a.totalArea(), 0.0);
+    EXPECT_THROW(shardedAggregate(container, 0), std::invalid_argument);
+    EXPECT_THROW(shardedAggregate(container, 2, Partition::Cell, 0.0), std::invalid_argument);
+}
+
+TEST(Sharding, WorkerAggregatesOnlyWhatItReceives) {
+    Array<FigurePtr> container;
+    fill_mixed(container, 300);
+    std::string wire;
+    for (auto const& f : container) codec::putFigure(wire, *f);
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        ::close(sv[1]);
+        bool ok = detail::writeAll(sv[0], wire.data(), wire.size());
+        ::_exit(ok ? 0 : 1);
+    }
+    ::close(sv[0]);
+    Aggregate part;
+    EXPECT_TRUE(detail::runShardWorker<T>(sv[1], part));
+    ::close(sv[1]);
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    expect_same_aggregate(part, aggregate(container));
+}
+
+TEST(CompactArray, DefaultEncodingKeepsLargeFigures) {
+    Array<FigurePtr> container;
+    for (int i = 0; i < 200; ++i) {
+        double r = 0.5 + i * 0.5;
+        std::ostringstream coords;
+        coords << std::setprecision(17);
+        for (int k = 0; k < 8; ++k)
+            coords << 100 + r * std::cos(k * M_PI / 4) << " " << 50 + r * std::sin(k * M_PI / 4) << " ";
+        container.push_back(create_octagon(coords.str()));
+    }
+    auto compact = CompactArray<T>::from(container);
+    ASSERT_EQ(compact.encoding(), Encoding::Int32);
+    for (std::size_t i = 0; i < container.size(); ++i)
+        EXPECT_EQ(compact.isCorrect(i), container[i]->isCorrect()) << "radius " << 0.5 + i * 0.5;
+    EXPECT_NEAR(compact.totalArea(), container.totalArea(), 1e-6 * container.totalArea());
+    EXPECT_GE(std::ranges::distance(container.valid()), 190);
+}
+
+TEST(Sharding, RejectsFiguresWorkersCannotRebuild) {
+    for (FigurePtr odd : {FigurePtr(std::make_shared<Pentagon>()), FigurePtr(std::make_shared<Quad>())}) {
+        Array<FigurePtr> container;
+        fill_mixed(container, 20);
+        container.push_back(odd);
+        EXPECT_EQ(aggregate(container).count, 21u);
+        EXPECT_THROW(shardedAggregate(container, 3), std::invalid_argument);
+    }
+}